@@ -3,6 +3,8 @@
 #include <vector>
 #include <array>
 #include "vapid/soa.h"
+#include "vapid/dict_string.h"
+#include "vapid/static_soa.h"
 
 using Id = unsigned short;
 
@@ -81,6 +83,30 @@ struct TestCase {
 const auto random_array_data = TestCase<ArraySensorData>::random();
 const auto random_string_data = TestCase<StringSensorData>::random();
 
+struct DictStringTestCase {
+    vapid::string_dictionary dictionary;
+    vapid::soa<Id, Id, double, vapid::dict_string> measurements_soa;
+
+    static DictStringTestCase from(const TestCase<StringSensorData>& string_data) {
+        DictStringTestCase t;
+        const auto& strings = string_data.measurements_soa.get_column<3>();
+        std::vector<std::string> raw;
+        raw.reserve(strings.size());
+        for (const auto& s : strings) {
+            raw.push_back(s.data);
+        }
+        t.dictionary = vapid::string_dictionary(raw.begin(), raw.end());
+        for (size_t i = 0; i < string_data.measurements_soa.size(); ++i) {
+            auto [sensor_id, object_id, timestamp, data] = string_data.measurements_soa[i];
+            t.measurements_soa.insert(sensor_id, object_id, timestamp, t.dictionary.encode(data.data));
+        }
+        t.measurements_soa.prepare_tmp();
+        return t;
+    }
+};
+
+const auto random_dict_string_data = DictStringTestCase::from(random_string_data);
+
 static void BM_SoaSortBySensorId_ArrayData(benchmark::State& state) {
     for (auto _ : state) {
         state.PauseTiming();
@@ -105,6 +131,19 @@ static void BM_SoaSortBySensorId_ArrayData_NoDoubleBuffering(benchmark::State& s
     }
 }
 
+static void BM_SoaSortBySensorIdAsync_ArrayData(benchmark::State& state) {
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto soa = random_array_data.measurements_soa;
+        state.ResumeTiming();
+
+        // the caller only blocks in commit_sort
+        soa.sort_by_field_async<0>();
+        soa.commit_sort();
+        benchmark::DoNotOptimize(soa.get_column<0>()[0]);
+    }
+}
+
 static void BM_SoaSortBySensorId_StringData(benchmark::State& state) {
     for (auto _ : state) {
         state.PauseTiming();
@@ -116,6 +155,39 @@ static void BM_SoaSortBySensorId_StringData(benchmark::State& state) {
     }
 }
 
+static void BM_SoaSortBySensorId_DictStringData(benchmark::State& state) {
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto soa = random_dict_string_data.measurements_soa;
+        state.ResumeTiming();
+
+        soa.sort_by_field<0>();
+        benchmark::DoNotOptimize(soa.get_column<0>()[0]);
+    }
+}
+
+static void BM_SoaSortByData_StringData(benchmark::State& state) {
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto soa = random_string_data.measurements_soa;
+        state.ResumeTiming();
+
+        soa.sort_by_field<3>([](auto& a, auto& b) { return a.data < b.data; });
+        benchmark::DoNotOptimize(soa.get_column<0>()[0]);
+    }
+}
+
+static void BM_SoaSortByData_DictStringData(benchmark::State& state) {
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto soa = random_dict_string_data.measurements_soa;
+        state.ResumeTiming();
+
+        soa.sort_by_field<3>();
+        benchmark::DoNotOptimize(soa.get_column<0>()[0]);
+    }
+}
+
 static void BM_VecSortBySensorId_ArrayData(benchmark::State& state) {
     for (auto _ : state) {
         state.PauseTiming();
@@ -168,16 +240,53 @@ static void BM_VecSumTimestamps_ArrayData(benchmark::State& state) {
     }
 }
 
+// per frame tables: build a small table from scratch, then sort it
+constexpr size_t SMALL_TABLE_CAPACITY = 512;
+
+static void BM_SoaSmallInsertSort_ArrayData(benchmark::State& state) {
+    const size_t num_rows = state.range(0);
+    const auto& src = random_array_data.measurements_vec;
+    for (auto _ : state) {
+        vapid::soa<Id, Id, double, ArraySensorData> soa;
+        for (size_t i = 0; i < num_rows; ++i) {
+            soa.insert(src[i].sensor_id, src[i].object_id, src[i].timestamp, src[i].data);
+        }
+        soa.sort_by_field<0>();
+        benchmark::DoNotOptimize(soa.get_column<0>()[0]);
+    }
+}
+
+static void BM_StaticSoaSmallInsertSort_ArrayData(benchmark::State& state) {
+    const size_t num_rows = state.range(0);
+    const auto& src = random_array_data.measurements_vec;
+    for (auto _ : state) {
+        vapid::static_soa<SMALL_TABLE_CAPACITY, Id, Id, double, ArraySensorData> soa;
+        for (size_t i = 0; i < num_rows; ++i) {
+            soa.insert(src[i].sensor_id, src[i].object_id, src[i].timestamp, src[i].data);
+        }
+        soa.sort_by_field<0>();
+        benchmark::DoNotOptimize(soa.get_column<0>()[0]);
+    }
+}
+
 
 // Register the function as a benchmark
 BENCHMARK(BM_SoaSortBySensorId_ArrayData);
 BENCHMARK(BM_SoaSortBySensorId_ArrayData_NoDoubleBuffering);
+BENCHMARK(BM_SoaSortBySensorIdAsync_ArrayData);
 BENCHMARK(BM_VecSortBySensorId_ArrayData);
 
 BENCHMARK(BM_SoaSortBySensorId_StringData);
+BENCHMARK(BM_SoaSortBySensorId_DictStringData);
 BENCHMARK(BM_VecSortBySensorId_StringData);
 
+BENCHMARK(BM_SoaSortByData_StringData);
+BENCHMARK(BM_SoaSortByData_DictStringData);
+
 BENCHMARK(BM_SoaSumTimestamps_ArrayData);
 BENCHMARK(BM_VecSumTimestamps_ArrayData);
+
+BENCHMARK(BM_SoaSmallInsertSort_ArrayData)->Arg(32)->Arg(128)->Arg(SMALL_TABLE_CAPACITY);
+BENCHMARK(BM_StaticSoaSmallInsertSort_ArrayData)->Arg(32)->Arg(128)->Arg(SMALL_TABLE_CAPACITY);
 // Run the benchmark
 BENCHMARK_MAIN();
@@ -1,6 +1,15 @@
 #include <gtest/gtest.h>
 #include <iostream>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <unordered_set>
 #include "vapid/soa.h"
+#include "vapid/join.h"
+#include "vapid/dict_string.h"
+#include "vapid/hash_index.h"
+#include "vapid/static_soa.h"
+#include "vapid/ring_soa.h"
 
 template <typename T>
 bool is_sorted(const std::vector<T>& l) {
@@ -21,3 +30,503 @@ TEST(SortA, Sorting) {
     soa.sort_by_field<0>();
     EXPECT_TRUE(is_sorted(soa.get_column<0>()));
 }
+
+TEST(MergeJoin, InnerJoin) {
+    // object_id, measurement
+    vapid::soa<int, double> measurements;
+    measurements.insert(3, 0.5);
+    measurements.insert(1, 1.5);
+    measurements.insert(2, 2.5);
+    measurements.insert(1, 3.5);
+    measurements.insert(7, 4.5);
+
+    // object_id, name
+    vapid::soa<int, std::string> objects;
+    objects.insert(2, "two");
+    objects.insert(1, "one");
+    objects.insert(3, "three");
+    objects.insert(5, "five");
+
+    auto joined = vapid::sort_and_join<0, 0>(measurements, objects);
+    ASSERT_EQ(joined.size(), 4);
+    EXPECT_EQ(joined[0], std::make_tuple(1, 1.5, 1, std::string("one")));
+    EXPECT_EQ(joined[1], std::make_tuple(1, 3.5, 1, std::string("one")));
+    EXPECT_EQ(joined[2], std::make_tuple(2, 2.5, 2, std::string("two")));
+    EXPECT_EQ(joined[3], std::make_tuple(3, 0.5, 3, std::string("three")));
+}
+
+TEST(MergeJoin, LeftJoin) {
+    vapid::soa<int> left;
+    vapid::soa<int> right;
+    for (int i : {1, 2, 2, 4}) {
+        left.insert(i);
+    }
+    for (int i : {2, 2, 3, 4}) {
+        right.insert(i);
+    }
+
+    auto rows = vapid::merge_join<0, 0>(left, right, vapid::JoinType::left);
+    vapid::join_rows expected = {
+        {0, vapid::no_match},
+        {1, 0}, {1, 1},
+        {2, 0}, {2, 1},
+        {3, 3}
+    };
+    EXPECT_EQ(rows, expected);
+}
+
+TEST(MergeJoin, ParallelMatchesSerial) {
+    vapid::soa<int> left;
+    vapid::soa<int> right;
+    for (int i = 0; i < 1000; ++i) {
+        left.insert((i * 7919) % 97);
+        right.insert((i * 104729) % 131);
+    }
+    left.sort_by_field<0>();
+    right.sort_by_field<0>();
+
+    for (auto join_type : {vapid::JoinType::inner, vapid::JoinType::left}) {
+        auto serial = vapid::merge_join<0, 0>(left, right, join_type);
+        auto parallel = vapid::merge_join_parallel<0, 0>(left, right, 4, join_type);
+        EXPECT_EQ(serial, parallel);
+    }
+}
+
+TEST(Project, ViewSharesColumns) {
+    vapid::soa<int, double, std::string> soa;
+    soa.insert(2, 0.5, "b");
+    soa.insert(1, 1.5, "a");
+
+    auto view = soa.project<2, 0>();
+    ASSERT_EQ(view.size(), 2);
+    EXPECT_EQ(&view.get_column<0>(), &soa.get_column<2>());
+    EXPECT_EQ(view[1], std::make_tuple(std::string("a"), 1));
+
+    // writes through the view land in the soa
+    std::get<0>(view.view<1>(0)) = 5;
+    EXPECT_EQ(soa.get_column<0>()[0], 5);
+
+    std::string concat;
+    for (auto [name, id] : view) {
+        concat += name + std::to_string(id);
+    }
+    EXPECT_EQ(concat, "b5a1");
+
+    const auto& const_soa = soa;
+    auto const_view = const_soa.project<1>();
+    static_assert(std::is_same<decltype(const_view.get_column<0>()),
+                               const std::vector<double>&>::value, "");
+}
+
+TEST(Project, ViewFollowsInserts) {
+    vapid::soa<int, double> soa;
+    soa.insert(1, 0.5);
+    auto view = soa.project<1>();
+    for (int i = 0; i < 100; ++i) {
+        soa.insert(i, double(i));
+    }
+    EXPECT_EQ(view.size(), 101);
+    EXPECT_EQ(view[100], std::make_tuple(99.0));
+
+    static_assert(vapid::distinct_indices<2, 0, 1>(), "");
+    static_assert(!vapid::distinct_indices<0, 1, 0>(), "");
+}
+
+TEST(Project, Extract) {
+    vapid::soa<int, double, std::string> soa;
+    soa.insert(2, 0.5, "b");
+    soa.insert(1, 1.5, "a");
+    const std::string* name_data = soa.get_column<2>().data();
+
+    auto extracted = std::move(soa).extract<2, 0>();
+    ASSERT_EQ(extracted.size(), 2);
+    EXPECT_EQ(extracted.get_column<0>().data(), name_data);
+    EXPECT_EQ(extracted[0], std::make_tuple(std::string("b"), 2));
+}
+
+TEST(DictString, SortByCodes) {
+    std::vector<std::string> names = {"carol", "alice", "bob", "alice", "carol"};
+    vapid::string_dictionary dict(names.begin(), names.end());
+    EXPECT_EQ(dict.size(), 3);
+    EXPECT_TRUE(dict.is_order_preserving());
+
+    vapid::soa<vapid::dict_string, int> soa;
+    for (size_t i = 0; i < names.size(); ++i) {
+        soa.insert(dict.encode(names[i]), int(i));
+    }
+    EXPECT_EQ(dict.size(), 3);
+
+    soa.sort_by_field<0>();
+    std::vector<std::string> decoded;
+    for (auto d : soa.get_column<0>()) {
+        decoded.push_back(dict.decode(d));
+    }
+    EXPECT_EQ(decoded, (std::vector<std::string>{"alice", "alice", "bob", "carol", "carol"}));
+    EXPECT_EQ(soa.get_column<1>(), (std::vector<int>{1, 3, 2, 0, 4}));
+
+    EXPECT_EQ(dict.find("bob"), soa.get_column<0>()[2]);
+    EXPECT_FALSE(dict.find("dave"));
+}
+
+TEST(DictString, SortCodes) {
+    vapid::string_dictionary dict;
+    vapid::soa<vapid::dict_string> soa;
+    for (std::string name : {"b", "c", "a"}) {
+        soa.insert(dict.encode(name));
+    }
+    EXPECT_FALSE(dict.is_order_preserving());
+
+    auto copy = dict;
+    EXPECT_EQ(copy.find("c"), soa.get_column<0>()[1]);
+
+    vapid::recode_column<0>(soa, dict.sort_codes());
+    EXPECT_TRUE(dict.is_order_preserving());
+    soa.sort_by_field<0>();
+    EXPECT_EQ(dict.decode(soa.get_column<0>()[0]), "a");
+    EXPECT_EQ(dict.decode(soa.get_column<0>()[1]), "b");
+    EXPECT_EQ(dict.decode(soa.get_column<0>()[2]), "c");
+}
+
+TEST(DictString, Hash) {
+    vapid::string_dictionary dict;
+    std::unordered_set<vapid::dict_string> seen;
+    for (std::string name : {"a", "b", "a", "c", "b"}) {
+        seen.insert(dict.encode(name));
+    }
+    EXPECT_EQ(seen.size(), 3);
+    EXPECT_EQ(seen.count(*dict.find("c")), 1);
+}
+
+TEST(HashIndex, LookupAndUpdate) {
+    vapid::soa<int, double> soa;
+    for (int i = 0; i < 100; ++i) {
+        soa.insert(i % 7, double(i));
+    }
+
+    auto index = vapid::make_hash_index<0>(soa);
+    EXPECT_EQ(index.num_keys(), 7);
+    EXPECT_EQ(index.rows(3), (std::vector<size_t>{3, 10, 17, 24, 31, 38, 45, 52, 59, 66, 73, 80, 87, 94}));
+    EXPECT_EQ(index.find(7), vapid::no_row);
+
+    soa.insert(7, 100.0);
+    soa.insert(3, 101.0);
+    index.update(soa.get_column<0>());
+    EXPECT_EQ(index.indexed_rows(), 102);
+    EXPECT_EQ(index.rows(7), (std::vector<size_t>{100}));
+    EXPECT_EQ(index.count(3), 15);
+
+    std::vector<size_t> first_rows;
+    index.probe({6, 8, 0}, first_rows);
+    EXPECT_EQ(first_rows, (std::vector<size_t>{6, vapid::no_row, 0}));
+}
+
+TEST(HashIndex, StridedKeys) {
+    // keys that only differ in their high bits, eg. nanosecond timestamps
+    vapid::open_addressing_map<size_t> map;
+    for (size_t i = 0; i < 10000; ++i) {
+        map.find_or_insert(i << 20, i);
+    }
+    EXPECT_EQ(map.size(), 10000);
+    EXPECT_EQ(map.find(size_t(1234) << 20), 1234);
+    EXPECT_EQ(map.find((size_t(1234) << 20) + 1), vapid::no_row);
+    // masking the low bits of the identity hash puts every key in one chain
+    EXPECT_LT(map.max_probe_length(), 64);
+}
+
+TEST(HashIndex, GroupBy) {
+    vapid::soa<int, double> soa;
+    for (int i = 0; i < 1000; ++i) {
+        soa.insert((i * 31) % 11, 1.0);
+    }
+
+    auto accumulate = [&](double& acc, size_t row) { acc += soa.get_column<1>()[row]; };
+    auto serial = vapid::hash_group_by<0>(soa, 0.0, accumulate);
+    ASSERT_EQ(serial.size(), 11);
+    EXPECT_EQ(serial.get_column<0>()[1], 31 % 11);
+    double total = 0;
+    for (double d : serial.get_column<1>()) {
+        total += d;
+    }
+    EXPECT_EQ(total, 1000.0);
+
+    auto parallel = vapid::hash_group_by_parallel<0>(soa, 0.0, accumulate,
+                                                     [](double& a, double b) { a += b; }, 4);
+    EXPECT_EQ(parallel.get_column<0>(), serial.get_column<0>());
+    EXPECT_EQ(parallel.get_column<1>(), serial.get_column<1>());
+}
+
+struct ModuloHash {
+    size_t operator()(int k) const {
+        return size_t(k % 3);
+    }
+};
+
+TEST(HashIndex, CustomHashAndDictString) {
+    vapid::string_dictionary dict;
+    vapid::soa<vapid::dict_string, int> soa;
+    for (std::string name : {"b", "a", "b", "c", "a", "b"}) {
+        soa.insert(dict.encode(name), 1);
+    }
+    auto counts = vapid::hash_group_by<0>(soa, 0, [](int& count, size_t) { ++count; });
+    ASSERT_EQ(counts.size(), 3);
+    EXPECT_EQ(dict.decode(counts.get_column<0>()[0]), "b");
+    EXPECT_EQ(counts.get_column<1>(), (std::vector<int>{3, 2, 1}));
+
+    vapid::soa<int> ints;
+    for (int i = 0; i < 10; ++i) {
+        ints.insert(i % 4);
+    }
+    auto index = vapid::make_hash_index<0, ModuloHash>(ints);
+    static_assert(std::is_same<decltype(index), vapid::hash_index<int, ModuloHash>>::value, "");
+    EXPECT_EQ(index.rows(3), (std::vector<size_t>{3, 7}));
+    auto groups = vapid::hash_group_by_parallel<0, ModuloHash>(
+        ints, 0, [](int& count, size_t) { ++count; }, [](int& a, int b) { a += b; }, 3);
+    EXPECT_EQ(groups.get_column<1>(), (std::vector<int>{3, 3, 2, 2}));
+}
+
+TEST(StaticSoa, Sorting) {
+    vapid::static_soa<64, int, std::string> soa;
+    for (int i = 0; i < 50; ++i) {
+        soa.insert((i * 17) % 5, std::to_string(i));
+    }
+    EXPECT_EQ(soa.size(), 50);
+
+    soa.sort_by_field<0>();
+    auto ids = soa.get_column<0>();
+    EXPECT_TRUE(std::is_sorted(ids.begin(), ids.end()));
+    EXPECT_EQ(soa[0], std::make_tuple(0, std::string("0")));
+    EXPECT_EQ(soa[1], std::make_tuple(0, std::string("5")));
+
+    soa.sort_by_view<1, 0>();
+    EXPECT_EQ(soa.view<1>(0), std::make_tuple(std::string("0")));
+    EXPECT_EQ(soa.view<1>(49), std::make_tuple(std::string("9")));
+}
+
+TEST(StaticSoa, ResizeValueInitializes) {
+    vapid::static_soa<4, int, std::string> soa;
+    soa.insert(7, "a");
+    soa.insert(8, "b");
+    soa.resize(1);
+    soa.resize(4);
+    EXPECT_EQ(soa[0], std::make_tuple(7, std::string("a")));
+    for (size_t row = 1; row < 4; ++row) {
+        EXPECT_EQ(soa[row], std::make_tuple(0, std::string()));
+    }
+}
+
+TEST(StaticSoa, Full) {
+    vapid::static_soa<2, int> soa;
+    EXPECT_TRUE(soa.insert(1));
+    EXPECT_TRUE(soa.insert(2));
+    EXPECT_TRUE(soa.full());
+    EXPECT_FALSE(soa.insert(3));
+    EXPECT_EQ(soa.size(), 2);
+    EXPECT_EQ(soa[1], std::make_tuple(2));
+
+    EXPECT_FALSE(soa.resize(3));
+    EXPECT_EQ(soa.size(), 2);
+    EXPECT_TRUE(soa.resize(1));
+    EXPECT_EQ(soa.size(), 1);
+}
+
+TEST(RingSoa, SlidingWindow) {
+    // timestamp, value
+    vapid::ring_soa<double, std::string> ring(4, /*growable=*/false);
+    for (int i = 0; i < 6; ++i) {
+        ring.push_back(double(i), std::to_string(i));
+    }
+    // the two oldest rows were evicted to make room
+    ASSERT_EQ(ring.size(), 4);
+    EXPECT_EQ(ring.capacity(), 4);
+    EXPECT_EQ(ring[0], std::make_tuple(2.0, std::string("2")));
+    EXPECT_EQ(ring.view<1>(3), std::make_tuple(std::string("5")));
+
+    auto [first, second] = ring.get_column_spans<0>();
+    EXPECT_EQ(first.size() + second.size(), 4);
+    EXPECT_EQ(second.size(), 2);
+    EXPECT_EQ(first[0], 2.0);
+    EXPECT_EQ(second[1], 5.0);
+
+    EXPECT_EQ(ring.evict_before<0>(3.5), 2);
+    EXPECT_EQ(ring.size(), 2);
+    EXPECT_EQ(ring[0], std::make_tuple(4.0, std::string("4")));
+
+    ring.pop_front();
+    EXPECT_EQ(ring[0], std::make_tuple(5.0, std::string("5")));
+}
+
+TEST(RingSoa, ZeroCapacityFixed) {
+    vapid::ring_soa<int> ring(0, /*growable=*/false);
+    ring.push_back(1);
+    ring.push_back(2);
+    EXPECT_EQ(ring.capacity(), 1);
+    ASSERT_EQ(ring.size(), 1);
+    EXPECT_EQ(ring[0], std::make_tuple(2));
+}
+
+TEST(RingSoa, GrowAndSort) {
+    vapid::ring_soa<int, int> ring(4);
+    for (int i = 0; i < 3; ++i) {
+        ring.push_back(i, i);
+    }
+    ring.pop_front(2);
+    for (int i = 3; i < 10; ++i) {
+        ring.push_back((i * 7) % 10, i);
+    }
+    ASSERT_EQ(ring.size(), 8);
+    EXPECT_GE(ring.capacity(), 8);
+    EXPECT_EQ(ring[0], std::make_tuple(2, 2));
+    EXPECT_EQ(ring[7], std::make_tuple(3, 9));
+
+    ring.pop_front(3);
+    ring.push_back(0, 10);
+    ring.sort_by_field<0>();
+    auto [first, second] = ring.get_column_spans<0>();
+    EXPECT_TRUE(second.empty());
+    EXPECT_EQ(std::vector<int>(first.begin(), first.end()), (std::vector<int>{0, 2, 3, 5, 6, 9}));
+    EXPECT_EQ(ring[0], std::make_tuple(0, 10));
+}
+
+TEST(AsyncSort, CommitSwapsBuffers) {
+    vapid::soa<int, std::string> soa;
+    for (int i = 0; i < 1000; ++i) {
+        soa.insert((i * 7919) % 1000, std::to_string(i));
+    }
+    const auto unsorted = soa.get_column<0>();
+
+    auto done = soa.sort_by_field_async<0>();
+    EXPECT_TRUE(soa.sort_pending());
+    // the front buffers are still readable and unchanged
+    EXPECT_EQ(soa.get_column<0>(), unsorted);
+
+    EXPECT_TRUE(done.get());
+    EXPECT_EQ(soa.get_column<0>(), unsorted);
+    EXPECT_TRUE(soa.commit_sort());
+    EXPECT_FALSE(soa.sort_pending());
+    EXPECT_TRUE(is_sorted(soa.get_column<0>()));
+    EXPECT_EQ(soa[0], std::make_tuple(0, std::string("0")));
+}
+
+TEST(AsyncSort, Executor) {
+    std::vector<std::function<void()>> queue;
+    auto executor = [&](std::function<void()> task) { queue.push_back(std::move(task)); };
+
+    vapid::soa<int, int> soa;
+    soa.insert(1, 0);
+    soa.insert(0, 1);
+    soa.insert(1, 2);
+
+    soa.sort_by_view_async<1, 0>([](auto a, auto b) { return a > b; }, executor);
+    EXPECT_FALSE(soa.try_commit_sort());
+    ASSERT_EQ(queue.size(), 1);
+    queue[0]();
+    EXPECT_TRUE(soa.try_commit_sort());
+    EXPECT_EQ(soa.get_column<1>(), (std::vector<int>{2, 1, 0}));
+}
+
+TEST(AsyncSort, InsertCancels) {
+    std::thread worker;
+    auto executor = [&](std::function<void()> task) { worker = std::thread(std::move(task)); };
+
+    vapid::soa<int> soa;
+    for (int i = 0; i < 100000; ++i) {
+        soa.insert(100000 - i);
+    }
+    auto done = soa.sort_by_field_async<0>(std::less<int>(), executor);
+    soa.insert(-1);
+    worker.join();
+
+    EXPECT_FALSE(soa.sort_pending());
+    EXPECT_FALSE(soa.commit_sort());
+    EXPECT_EQ(soa.get_column<0>()[0], 100000);
+    EXPECT_EQ(soa.get_column<0>().back(), -1);
+
+    // a cancelled sort may still have finished
+    // either way its result was discarded
+    EXPECT_EQ(done.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+}
+
+TEST(AsyncSort, InsertCancelsRunningComparator) {
+    std::thread worker;
+    auto executor = [&](std::function<void()> task) { worker = std::thread(std::move(task)); };
+
+    // the comparator holds the sort until the test has asked it to stop
+    std::promise<void> entered;
+    std::promise<void> released;
+    std::shared_future<void> release = released.get_future().share();
+    std::atomic<bool> first{true};
+    auto comparator = [&](int a, int b) {
+        if (first.exchange(false)) {
+            entered.set_value();
+            release.wait();
+        }
+        return a < b;
+    };
+
+    vapid::soa<int> soa;
+    for (int i = 0; i < 1000; ++i) {
+        soa.insert(1000 - i);
+    }
+    auto done = soa.sort_by_field_async<0>(comparator, executor);
+    entered.get_future().wait();
+    soa.request_cancel_sort();
+    EXPECT_TRUE(soa.sort_pending());
+    released.set_value();
+
+    soa.insert(-1);
+    worker.join();
+    EXPECT_FALSE(done.get());
+    EXPECT_FALSE(soa.sort_pending());
+    EXPECT_EQ(soa.get_column<0>()[0], 1000);
+    EXPECT_EQ(soa.get_column<0>().back(), -1);
+}
+
+TEST(AsyncSort, InsertBeforeTaskStarts) {
+    std::vector<std::function<void()>> queue;
+    auto executor = [&](std::function<void()> task) { queue.push_back(std::move(task)); };
+
+    std::shared_future<bool> done;
+    {
+        vapid::soa<int> soa;
+        soa.insert(1);
+        soa.insert(0);
+        done = soa.sort_by_field_async<0>(std::less<int>(), executor);
+        // does not wait for the queued task
+        soa.insert(2);
+        EXPECT_FALSE(soa.sort_pending());
+        EXPECT_EQ(soa.get_column<0>(), (std::vector<int>{1, 0, 2}));
+
+        soa.sort_by_field_async<0>(std::less<int>(), executor);
+        soa.request_cancel_sort();
+        EXPECT_FALSE(soa.try_commit_sort());
+        EXPECT_FALSE(soa.sort_pending());
+    }
+
+    // the abandoned tasks run after their soa is gone without touching it
+    ASSERT_EQ(queue.size(), 2);
+    for (auto& task : queue) {
+        task();
+    }
+    EXPECT_FALSE(done.get());
+}
+
+TEST(AsyncSort, ExecutorFailures) {
+    vapid::soa<int> soa;
+    soa.insert(1);
+    soa.insert(0);
+
+    // an executor that throws leaves no sort pending
+    auto throwing = [](std::function<void()>) { throw std::runtime_error("no threads"); };
+    EXPECT_THROW(soa.sort_by_field_async<0>(std::less<int>(), throwing), std::runtime_error);
+    EXPECT_FALSE(soa.sort_pending());
+
+    // a dropped task never started, so cancel_sort does not wait for it
+    auto dropping = [](std::function<void()>) {};
+    soa.sort_by_field_async<0>(std::less<int>(), dropping);
+    soa.insert(2);
+    EXPECT_FALSE(soa.sort_pending());
+    EXPECT_EQ(soa.get_column<0>(), (std::vector<int>{1, 0, 2}));
+}
+
+static_assert(std::is_nothrow_move_constructible<vapid::soa<int, double>>::value, "");
+static_assert(std::is_nothrow_move_assignable<vapid::soa<int, double>>::value, "");
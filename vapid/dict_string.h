@@ -0,0 +1,185 @@
+#ifndef VAPID_DICT_STRING_H
+#define VAPID_DICT_STRING_H
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "vapid/soa.h"
+
+namespace vapid {
+
+    // A dictionary encoded string, to be stored as a soa column
+    // in place of std::string. The string itself lives in a
+    // string_dictionary, the column only holds its integer code.
+    // Sorting, grouping and equality tests run on the codes.
+    struct dict_string {
+        using code_type = uint32_t;
+        code_type code = 0;
+
+        friend bool operator==(dict_string a, dict_string b) { return a.code == b.code; }
+        friend bool operator!=(dict_string a, dict_string b) { return a.code != b.code; }
+        friend bool operator<(dict_string a, dict_string b) { return a.code < b.code; }
+        friend bool operator<=(dict_string a, dict_string b) { return a.code <= b.code; }
+        friend bool operator>(dict_string a, dict_string b) { return a.code > b.code; }
+        friend bool operator>=(dict_string a, dict_string b) { return a.code >= b.code; }
+    };
+
+    inline std::ostream& operator<<(std::ostream& cout, dict_string s) {
+        cout << "#" << s.code;
+        return cout;
+    }
+
+    class string_dictionary {
+    public:
+        using code_type = dict_string::code_type;
+
+        string_dictionary() {}
+
+        // Builds an order preserving dictionary holding each
+        // distinct string of [begin, end) exactly once.
+        template <typename It>
+        string_dictionary(It begin, It end) {
+            std::vector<std::string> strings(begin, end);
+            std::sort(strings.begin(), strings.end());
+            strings.erase(std::unique(strings.begin(), strings.end()), strings.end());
+            for (auto& s : strings) {
+                append(std::move(s));
+            }
+        }
+
+        string_dictionary(const string_dictionary& other) : pool_(other.pool_), order_preserving_(other.order_preserving_) {
+            rebuild_codes();
+        }
+
+        string_dictionary& operator=(const string_dictionary& other) {
+            pool_ = other.pool_;
+            order_preserving_ = other.order_preserving_;
+            rebuild_codes();
+            return *this;
+        }
+
+        // moving a deque keeps its elements in place, so the
+        // string_views held by codes_ stay valid
+        string_dictionary(string_dictionary&&) = default;
+        string_dictionary& operator=(string_dictionary&&) = default;
+
+        // Returns the code of s, adding s to the dictionary if it is new.
+        // Codes stay order preserving as long as new strings are added
+        // in increasing order; otherwise see sort_codes.
+        dict_string encode(const std::string& s) {
+            auto it = codes_.find(s);
+            if (it != codes_.end()) {
+                return dict_string{it->second};
+            }
+            if (!pool_.empty() && !(pool_.back() < s)) {
+                order_preserving_ = false;
+            }
+            return append(s);
+        }
+
+        // Code of s, or nullopt if s was never encoded.
+        // Useful for equality filters: compare the code column
+        // against the result instead of comparing strings.
+        std::optional<dict_string> find(std::string_view s) const {
+            auto it = codes_.find(s);
+            if (it == codes_.end()) {
+                return std::nullopt;
+            }
+            return dict_string{it->second};
+        }
+
+        const std::string& decode(dict_string s) const {
+            return pool_[s.code];
+        }
+
+        size_t size() const {
+            return pool_.size();
+        }
+
+        bool empty() const {
+            return pool_.empty();
+        }
+
+        // True if comparing codes gives the same order as comparing strings.
+        bool is_order_preserving() const {
+            return order_preserving_;
+        }
+
+        // Renumbers the codes so that they are order preserving again.
+        // Returns remap where remap[old_code] = new_code. Columns encoded
+        // with this dictionary must be updated, eg. with recode_column.
+        std::vector<code_type> sort_codes() {
+            std::vector<code_type> by_string(pool_.size());
+            for (size_t i = 0; i < by_string.size(); ++i) {
+                by_string[i] = code_type(i);
+            }
+            std::sort(by_string.begin(), by_string.end(), [&](code_type a, code_type b) {
+                return pool_[a] < pool_[b];
+            });
+
+            std::vector<code_type> remap(pool_.size());
+            std::deque<std::string> sorted_pool;
+            for (size_t i = 0; i < by_string.size(); ++i) {
+                remap[by_string[i]] = code_type(i);
+                sorted_pool.push_back(std::move(pool_[by_string[i]]));
+            }
+            pool_ = std::move(sorted_pool);
+            order_preserving_ = true;
+            rebuild_codes();
+            return remap;
+        }
+
+    private:
+        dict_string append(std::string s) {
+            code_type code = code_type(pool_.size());
+            pool_.push_back(std::move(s));
+            codes_.emplace(pool_.back(), code);
+            return dict_string{code};
+        }
+
+        void rebuild_codes() {
+            codes_.clear();
+            codes_.reserve(pool_.size());
+            for (size_t i = 0; i < pool_.size(); ++i) {
+                codes_.emplace(pool_[i], code_type(i));
+            }
+        }
+
+        // pool_[code] is the string with that code
+        // a deque is used so that strings never move once added
+        std::deque<std::string> pool_;
+
+        // keys point into pool_
+        std::unordered_map<std::string_view, code_type> codes_;
+
+        bool order_preserving_ = true;
+    };
+
+    // Applies the remap returned by string_dictionary::sort_codes
+    // to a dict_string column of a soa.
+    template <size_t col_idx, typename... Ts>
+    void recode_column(soa<Ts...>& s, const std::vector<dict_string::code_type>& remap) {
+        for (auto& d : s.template get_column<col_idx>()) {
+            d.code = remap[d.code];
+        }
+    }
+}
+
+namespace std {
+    // lets dict_string columns be hashed and grouped by code, eg. with hash_group_by
+    template <>
+    struct hash<vapid::dict_string> {
+        size_t operator()(vapid::dict_string s) const {
+            return hash<vapid::dict_string::code_type>()(s.code);
+        }
+    };
+}
+
+#endif /* VAPID_DICT_STRING_H */
@@ -0,0 +1,315 @@
+#ifndef VAPID_HASH_INDEX_H
+#define VAPID_HASH_INDEX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "vapid/soa.h"
+
+namespace vapid {
+
+    // row index reported for keys which are not in a hash_index
+    constexpr size_t no_row = std::numeric_limits<size_t>::max();
+
+    // Open addressing (linear probing) hash map from keys to
+    // size_t values. Used by hash_index and hash_group_by to
+    // map each distinct key to a dense group number.
+    template <typename K, typename Hash = std::hash<K>>
+    class open_addressing_map {
+    public:
+        // Returns the value stored for key and true,
+        // or inserts value_if_new and returns it and false.
+        std::pair<size_t, bool> find_or_insert(const K& key, size_t value_if_new) {
+            if (2 * (size_ + 1) > slots_.size()) {
+                rehash(std::max<size_t>(16, 2 * slots_.size()));
+            }
+            size_t pos = find_slot(key);
+            if (slots_[pos].value != no_row) {
+                return { slots_[pos].value, true };
+            }
+            slots_[pos].key = key;
+            slots_[pos].value = value_if_new;
+            ++size_;
+            return { value_if_new, false };
+        }
+
+        // value stored for key, or no_row
+        size_t find(const K& key) const {
+            if (slots_.empty()) {
+                return no_row;
+            }
+            return slots_[find_slot(key)].value;
+        }
+
+        size_t size() const {
+            return size_;
+        }
+
+        void clear() {
+            slots_.clear();
+            size_ = 0;
+        }
+
+        // longest distance from a key's home slot to the slot holding it
+        // a measure of how well Hash spreads the keys
+        size_t max_probe_length() const {
+            const size_t mask = slots_.size() - 1;
+            size_t result = 0;
+            for (size_t pos = 0; pos < slots_.size(); ++pos) {
+                if (slots_[pos].value != no_row) {
+                    result = std::max(result, (pos - home_slot(slots_[pos].key)) & mask);
+                }
+            }
+            return result;
+        }
+
+    private:
+        struct Slot {
+            K key;
+            size_t value = no_row;
+        };
+
+        // the slot holding key, or the empty slot where it would go
+        size_t find_slot(const K& key) const {
+            const size_t mask = slots_.size() - 1;
+            size_t pos = home_slot(key);
+            while (slots_[pos].value != no_row && !(slots_[pos].key == key)) {
+                pos = (pos + 1) & mask;
+            }
+            return pos;
+        }
+
+        // Fibonacci hashing: takes the top bits of hash * 2^64/phi.
+        // std::hash of integers is the identity in libstdc++, so using its
+        // low bits directly would pile strided keys into one probe chain.
+        size_t home_slot(const K& key) const {
+            return size_t((uint64_t(hash_(key)) * 0x9E3779B97F4A7C15ull) >> shift_);
+        }
+
+        void rehash(size_t new_capacity) {
+            // capacity is kept a power of 2 so probing can use a mask
+            shift_ = 64;
+            for (size_t c = new_capacity; c > 1; c /= 2) {
+                --shift_;
+            }
+            std::vector<Slot> old_slots(new_capacity);
+            std::swap(old_slots, slots_);
+            for (auto& slot : old_slots) {
+                if (slot.value != no_row) {
+                    Slot& dst = slots_[find_slot(slot.key)];
+                    dst.key = std::move(slot.key);
+                    dst.value = slot.value;
+                }
+            }
+        }
+
+        std::vector<Slot> slots_;
+        size_t size_ = 0;
+        // 64 - log2(capacity)
+        unsigned shift_ = 64;
+        Hash hash_;
+    };
+
+    template <typename K, typename Hash = std::hash<K>>
+    class hash_index {
+        /* Maps each key of a column to the rows holding that key.
+         * Rows with equal keys are chained in increasing row order,
+         * so the index stores one group per distinct key plus one
+         * link per row.
+         *
+         * The index refers to rows by position. It has to be rebuilt
+         * (clear() then update()) after the soa is sorted or erased from.
+         * Rows appended with insert() are picked up by update().
+         */
+    public:
+        hash_index() {}
+
+        // Indexes the rows of column that were appended since the last update.
+        void update(const std::vector<K>& column) {
+            for (size_t row = next_.size(); row < column.size(); ++row) {
+                auto [group, existed] = groups_.find_or_insert(column[row], heads_.size());
+                if (existed) {
+                    next_[tails_[group]] = row;
+                    tails_[group] = row;
+                } else {
+                    heads_.push_back(row);
+                    tails_.push_back(row);
+                }
+                next_.push_back(no_row);
+            }
+        }
+
+        void clear() {
+            groups_.clear();
+            heads_.clear();
+            tails_.clear();
+            next_.clear();
+        }
+
+        // number of rows covered by the index
+        size_t indexed_rows() const {
+            return next_.size();
+        }
+
+        // number of distinct keys
+        size_t num_keys() const {
+            return heads_.size();
+        }
+
+        // first row holding key, or no_row
+        size_t find(const K& key) const {
+            size_t group = groups_.find(key);
+            return group == no_row ? no_row : heads_[group];
+        }
+
+        // next row holding the same key as row, or no_row
+        size_t next(size_t row) const {
+            return next_[row];
+        }
+
+        template <typename F>
+        void for_each_row(const K& key, F&& f) const {
+            for (size_t row = find(key); row != no_row; row = next_[row]) {
+                f(row);
+            }
+        }
+
+        std::vector<size_t> rows(const K& key) const {
+            std::vector<size_t> result;
+            for_each_row(key, [&](size_t row) { result.push_back(row); });
+            return result;
+        }
+
+        size_t count(const K& key) const {
+            size_t result = 0;
+            for_each_row(key, [&](size_t) { ++result; });
+            return result;
+        }
+
+        // Batched lookup: first_rows[i] = find(keys[i])
+        void probe(const std::vector<K>& keys, std::vector<size_t>& first_rows) const {
+            first_rows.resize(keys.size());
+            for (size_t i = 0; i < keys.size(); ++i) {
+                first_rows[i] = find(keys[i]);
+            }
+        }
+
+    private:
+        // key => group number
+        open_addressing_map<K, Hash> groups_;
+
+        // first and last row of each group
+        std::vector<size_t> heads_;
+        std::vector<size_t> tails_;
+
+        // next row in the same group, for every row
+        std::vector<size_t> next_;
+    };
+
+    // The free functions below take an optional Hash after the column index,
+    // eg. hash_group_by<0, MyHash>(...). void stands for std::hash of the key.
+    template <typename Hash, typename K>
+    using hash_or_default = typename std::conditional<std::is_void<Hash>::value, std::hash<K>, Hash>::type;
+
+    template <size_t col_idx, typename Hash = void, typename... Ts>
+    auto make_hash_index(const soa<Ts...>& s) {
+        using K = typename soa<Ts...>::template col_type<col_idx>;
+        hash_index<K, hash_or_default<Hash, K>> index;
+        index.update(s.template get_column<col_idx>());
+        return index;
+    }
+
+    // accumulates rows [begin, end) into one A per distinct key,
+    // keeping groups in order of first appearance
+    template <typename K, typename A, typename F, typename Hash>
+    void hash_group_range(const std::vector<K>& keys,
+                          size_t begin,
+                          size_t end,
+                          const A& init,
+                          F&& accumulate,
+                          open_addressing_map<K, Hash>& groups,
+                          std::vector<K>& group_keys,
+                          std::vector<A>& group_accs) {
+        for (size_t row = begin; row < end; ++row) {
+            auto [group, existed] = groups.find_or_insert(keys[row], group_keys.size());
+            if (!existed) {
+                group_keys.push_back(keys[row]);
+                group_accs.push_back(init);
+            }
+            accumulate(group_accs[group], row);
+        }
+    }
+
+    // Aggregates the rows of s grouped by column key_col without
+    // reordering s. accumulate(A& acc, size_t row) folds a row into
+    // its group's accumulator, which starts out as init.
+    // Returns a soa of (key, accumulator), in order of first appearance.
+    template <size_t key_col, typename Hash = void, typename A, typename F, typename... Ts>
+    soa<typename soa<Ts...>::template col_type<key_col>, A>
+    hash_group_by(const soa<Ts...>& s, const A& init, F&& accumulate) {
+        using K = typename soa<Ts...>::template col_type<key_col>;
+        soa<K, A> result;
+        open_addressing_map<K, hash_or_default<Hash, K>> groups;
+        hash_group_range(s.template get_column<key_col>(), 0, s.size(), init, accumulate,
+                         groups, result.template get_column<0>(), result.template get_column<1>());
+        return result;
+    }
+
+    // Same as hash_group_by, but the rows are split into num_threads
+    // ranges, each aggregated into a thread local table. The tables
+    // are then combined with merge(A& acc, const A& other).
+    // accumulate runs concurrently on several threads, possibly for equal
+    // keys, since each thread folds into its own accumulators. It must be
+    // safe to call that way as long as it only modifies the given acc.
+    template <size_t key_col, typename Hash = void, typename A, typename F, typename M, typename... Ts>
+    soa<typename soa<Ts...>::template col_type<key_col>, A>
+    hash_group_by_parallel(const soa<Ts...>& s, const A& init, F&& accumulate, M&& merge, size_t num_threads) {
+        using K = typename soa<Ts...>::template col_type<key_col>;
+        const auto& keys = s.template get_column<key_col>();
+        num_threads = std::max<size_t>(1, std::min(num_threads, keys.size()));
+
+        std::vector<open_addressing_map<K, hash_or_default<Hash, K>>> groups(num_threads);
+        std::vector<std::vector<K>> group_keys(num_threads);
+        std::vector<std::vector<A>> group_accs(num_threads);
+
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < num_threads; ++t) {
+            workers.emplace_back([&, t]() {
+                hash_group_range(keys,
+                                 keys.size() * t / num_threads,
+                                 keys.size() * (t+1) / num_threads,
+                                 init, accumulate,
+                                 groups[t], group_keys[t], group_accs[t]);
+            });
+        }
+        for (auto& w : workers) {
+            w.join();
+        }
+
+        // merge into the first table
+        // ranges are in row order, so groups stay in order of first appearance
+        for (size_t t = 1; t < num_threads; ++t) {
+            for (size_t g = 0; g < group_keys[t].size(); ++g) {
+                auto [group, existed] = groups[0].find_or_insert(group_keys[t][g], group_keys[0].size());
+                if (existed) {
+                    merge(group_accs[0][group], group_accs[t][g]);
+                } else {
+                    group_keys[0].push_back(std::move(group_keys[t][g]));
+                    group_accs[0].push_back(std::move(group_accs[t][g]));
+                }
+            }
+        }
+
+        soa<K, A> result;
+        result.template get_column<0>() = std::move(group_keys[0]);
+        result.template get_column<1>() = std::move(group_accs[0]);
+        return result;
+    }
+}
+
+#endif /* VAPID_HASH_INDEX_H */
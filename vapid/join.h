@@ -0,0 +1,202 @@
+#ifndef VAPID_JOIN_H
+#define VAPID_JOIN_H
+
+#include <algorithm>
+#include <limits>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "vapid/soa.h"
+
+namespace vapid {
+
+    enum class JoinType {
+        inner, // only rows whose key appears in both tables
+        left   // every left row, with no_match on the right if its key is missing
+    };
+
+    // right row index reported for unmatched left rows in a left join
+    constexpr size_t no_match = std::numeric_limits<size_t>::max();
+
+    using join_rows = std::vector<std::pair<size_t, size_t>>;
+
+    // Streaming merge of the left rows [left_begin, left_end) against
+    // the whole right column. Both columns must already be sorted by
+    // `less`. Matching pairs are appended to `out` in left row order.
+    template <typename L, typename R, typename C>
+    void merge_join_range(const std::vector<L>& left_keys,
+                          const std::vector<R>& right_keys,
+                          size_t left_begin,
+                          size_t left_end,
+                          JoinType join_type,
+                          C&& less,
+                          join_rows& out) {
+        if (left_begin >= left_end) {
+            return;
+        }
+
+        // jump straight to the first right key that could match
+        size_t r = std::lower_bound(right_keys.begin(), right_keys.end(),
+                                    left_keys[left_begin],
+                                    [&](const R& a, const L& b) { return less(a, b); })
+            - right_keys.begin();
+
+        size_t l = left_begin;
+        while (l < left_end) {
+            while (r < right_keys.size() && less(right_keys[r], left_keys[l])) {
+                ++r;
+            }
+
+            if (r == right_keys.size() || less(left_keys[l], right_keys[r])) {
+                if (join_type == JoinType::left) {
+                    out.emplace_back(l, no_match);
+                }
+                ++l;
+                continue;
+            }
+
+            // left_keys[l] == right_keys[r]
+            // find the extent of the equal run on the right
+            size_t r_end = r + 1;
+            while (r_end < right_keys.size() && !less(left_keys[l], right_keys[r_end])) {
+                ++r_end;
+            }
+
+            // every left row with this key pairs with the whole right run
+            const size_t l_run = l;
+            do {
+                for (size_t i = r; i < r_end; ++i) {
+                    out.emplace_back(l, i);
+                }
+                ++l;
+            } while (l < left_end &&
+                     !less(left_keys[l_run], left_keys[l]));
+
+            r = r_end;
+        }
+    }
+
+    // Row index pairs (left_row, right_row) of the join of two soas
+    // on left column `left_key` and right column `right_key`.
+    // Both soas must already be sorted on their key columns by `less`,
+    // eg. with sort_by_field<key>(less).
+    template <size_t left_key, size_t right_key, typename C, typename... Ls, typename... Rs>
+    join_rows merge_join(const soa<Ls...>& left,
+                         const soa<Rs...>& right,
+                         JoinType join_type,
+                         C&& less) {
+        join_rows out;
+        merge_join_range(left.template get_column<left_key>(),
+                         right.template get_column<right_key>(),
+                         0, left.size(), join_type, less, out);
+        return out;
+    }
+
+    template <size_t left_key, size_t right_key, typename... Ls, typename... Rs>
+    join_rows merge_join(const soa<Ls...>& left,
+                         const soa<Rs...>& right,
+                         JoinType join_type = JoinType::inner) {
+        return merge_join<left_key, right_key>(left, right, join_type,
+                                               [](auto&& a, auto&& b) { return a < b; });
+    }
+
+    // Same result as merge_join, but the left table is partitioned
+    // into num_threads key ranges which are merged concurrently.
+    // Partition boundaries are moved forward so that a run of equal
+    // keys is never split across threads.
+    template <size_t left_key, size_t right_key, typename C, typename... Ls, typename... Rs>
+    join_rows merge_join_parallel(const soa<Ls...>& left,
+                                  const soa<Rs...>& right,
+                                  size_t num_threads,
+                                  JoinType join_type,
+                                  C&& less) {
+        const auto& left_keys = left.template get_column<left_key>();
+        const auto& right_keys = right.template get_column<right_key>();
+
+        num_threads = std::max<size_t>(1, std::min(num_threads, left_keys.size()));
+
+        std::vector<size_t> bounds = { 0 };
+        for (size_t t = 1; t < num_threads; ++t) {
+            size_t b = std::max(bounds.back(), left_keys.size() * t / num_threads);
+            while (b > 0 && b < left_keys.size() &&
+                   !less(left_keys[b-1], left_keys[b])) {
+                ++b;
+            }
+            bounds.push_back(b);
+        }
+        bounds.push_back(left_keys.size());
+
+        std::vector<join_rows> partials(num_threads);
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < num_threads; ++t) {
+            workers.emplace_back([&, t]() {
+                merge_join_range(left_keys, right_keys,
+                                 bounds[t], bounds[t+1],
+                                 join_type, less, partials[t]);
+            });
+        }
+
+        size_t total = 0;
+        for (size_t t = 0; t < num_threads; ++t) {
+            workers[t].join();
+            total += partials[t].size();
+        }
+
+        join_rows out;
+        out.reserve(total);
+        for (const auto& p : partials) {
+            out.insert(out.end(), p.begin(), p.end());
+        }
+        return out;
+    }
+
+    template <size_t left_key, size_t right_key, typename... Ls, typename... Rs>
+    join_rows merge_join_parallel(const soa<Ls...>& left,
+                                  const soa<Rs...>& right,
+                                  size_t num_threads,
+                                  JoinType join_type = JoinType::inner) {
+        return merge_join_parallel<left_key, right_key>(left, right, num_threads, join_type,
+                                                        [](auto&& a, auto&& b) { return a < b; });
+    }
+
+    // Materialize joined rows into a new soa holding all the left
+    // columns followed by all the right columns. Right columns of
+    // unmatched left rows (left join) are value initialized.
+    template <typename... Ls, typename... Rs>
+    soa<Ls..., Rs...> gather_join(const soa<Ls...>& left,
+                                  const soa<Rs...>& right,
+                                  const join_rows& rows) {
+        soa<Ls..., Rs...> result;
+        result.reserve(rows.size());
+
+        auto insert_row = [&](auto&&... xs) { result.insert(xs...); };
+        for (const auto& [l, r] : rows) {
+            if (r == no_match) {
+                std::apply(insert_row, std::tuple_cat(left[l], std::tuple<Rs...>{}));
+            } else {
+                std::apply(insert_row, std::tuple_cat(left[l], right[r]));
+            }
+        }
+        return result;
+    }
+
+    template <size_t left_key, size_t right_key, typename... Ls, typename... Rs>
+    soa<Ls..., Rs...> join(const soa<Ls...>& left,
+                           const soa<Rs...>& right,
+                           JoinType join_type = JoinType::inner) {
+        return gather_join(left, right, merge_join<left_key, right_key>(left, right, join_type));
+    }
+
+    // Sorts both tables on their key columns with sort_by_field
+    // and then joins them.
+    template <size_t left_key, size_t right_key, typename... Ls, typename... Rs>
+    soa<Ls..., Rs...> sort_and_join(soa<Ls...>& left,
+                                    soa<Rs...>& right,
+                                    JoinType join_type = JoinType::inner) {
+        left.template sort_by_field<left_key>();
+        right.template sort_by_field<right_key>();
+        return join<left_key, right_key>(left, right, join_type);
+    }
+}
+
+#endif /* VAPID_JOIN_H */
@@ -0,0 +1,297 @@
+#ifndef VAPID_RING_SOA_H
+#define VAPID_RING_SOA_H
+
+#include <algorithm>
+#include <ostream>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "vapid/soa.h"
+#include "vapid/span.h"
+
+namespace vapid {
+
+    template <typename... Ts>
+    class ring_soa {
+        /* A structure of arrays used as a circular buffer, for keeping
+         * a sliding window of rows, eg. the last few seconds of a time series.
+         * push_back and pop_front are O(1) and never move the other rows.
+         *
+         * Row indices are logical: row 0 is the oldest row in the window.
+         * Physically, a column is stored in at most two contiguous
+         * pieces, see get_column_spans.
+         *
+         * If the ring is growable, push_back on a full ring doubles the
+         * capacity. Otherwise it evicts the oldest row, except that a
+         * non-growable ring of capacity 0 first grows to hold one row.
+         */
+    public:
+        using backing_type = std::tuple<std::vector<Ts>...>;
+
+        template <size_t col_idx>
+        using col_type = typename std::tuple_element<col_idx, std::tuple<Ts...>>::type;
+
+        ring_soa(size_t capacity = 0, bool growable = true) : growable_(growable) {
+            resize_impl(std::index_sequence_for<Ts...>{}, data_, capacity);
+        }
+
+        size_t size() const {
+            return size_;
+        }
+
+        bool empty() const {
+            return size_ == 0;
+        }
+
+        size_t capacity() const {
+            return std::get<0>(data_).size();
+        }
+
+        bool full() const {
+            return size_ == capacity();
+        }
+
+        // Grows the ring to hold at least capacity rows.
+        void reserve(size_t capacity) {
+            if (capacity > this->capacity()) {
+                relocate(capacity, [](size_t row) { return row; });
+            }
+        }
+
+        template <typename... Xs>
+        void push_back(Xs... xs) {
+            if (full()) {
+                if (growable_) {
+                    reserve(std::max<size_t>(16, 2 * capacity()));
+                } else if (capacity() == 0) {
+                    reserve(1);
+                } else {
+                    pop_front();
+                }
+            }
+            insert_impl(std::index_sequence_for<Ts...>{}, std::forward_as_tuple(xs...), physical_row(size_));
+            ++size_;
+        }
+
+        // Drops the n oldest rows.
+        // The dropped elements are not destroyed until they are overwritten.
+        void pop_front(size_t n = 1) {
+            n = std::min(n, size_);
+            head_ = wrap(head_ + n);
+            size_ -= n;
+            if (size_ == 0) {
+                head_ = 0;
+            }
+        }
+
+        // Drops rows from the front while their col_idx field is less than threshold.
+        // Meant for a timestamp column that increases with each push_back.
+        // Returns the number of rows dropped.
+        template <size_t col_idx, typename T>
+        size_t evict_before(const T& threshold) {
+            const auto& col = std::get<col_idx>(data_);
+            size_t n = 0;
+            while (n < size_ && col[physical_row(n)] < threshold) {
+                ++n;
+            }
+            pop_front(n);
+            return n;
+        }
+
+        void clear() {
+            head_ = 0;
+            size_ = 0;
+        }
+
+        auto operator[](size_t idx) const {
+            return get_row_impl(std::index_sequence_for<Ts...>{}, physical_row(idx));
+        }
+
+        auto operator[](size_t idx) {
+            return get_row_impl(std::index_sequence_for<Ts...>{}, physical_row(idx));
+        }
+
+        template <size_t... I>
+        auto view(size_t row) const {
+            return get_row_impl(std::integer_sequence<size_t, I...>{}, physical_row(row));
+        }
+
+        template <size_t... I>
+        auto view(size_t row) {
+            return get_row_impl(std::integer_sequence<size_t, I...>{}, physical_row(row));
+        }
+
+        // The rows of a column in logical order, as two contiguous pieces.
+        // The second piece is empty unless the window wraps around.
+        template <size_t col_idx>
+        std::pair<column_span<const col_type<col_idx>>, column_span<const col_type<col_idx>>>
+        get_column_spans() const {
+            return get_column_spans_impl<const col_type<col_idx>>(std::get<col_idx>(data_).data());
+        }
+
+        template <size_t col_idx>
+        std::pair<column_span<col_type<col_idx>>, column_span<col_type<col_idx>>>
+        get_column_spans() {
+            return get_column_spans_impl<col_type<col_idx>>(std::get<col_idx>(data_).data());
+        }
+
+        // Moves the window to the start of the buffers, so that
+        // the first span of every column holds all the rows.
+        void linearize() {
+            if (head_ + size_ > capacity()) {
+                relocate(capacity(), [](size_t row) { return row; });
+            }
+        }
+
+        // Sorts the rows in the window. This linearizes the ring.
+        // Once sorted, evict_before may no longer be meaningful.
+        template <size_t col_idx, typename C>
+        void sort_by_field(C&& comparator) {
+            reset_sort_reference();
+
+            const auto& col = std::get<col_idx>(data_);
+
+            auto comparator_wrapper = [&](size_t a, size_t b) {
+                return comparator(col[physical_row(a)], col[physical_row(b)]);
+            };
+
+            std::stable_sort(sort_order_reference_.begin(),
+                sort_order_reference_.end(),
+                comparator_wrapper);
+
+            relocate(capacity(), [&](size_t row) { return sort_order_reference_[row]; });
+        }
+
+        template <size_t col_idx>
+        void sort_by_field() {
+            sort_by_field<col_idx>([](auto&& a, auto&& b) { return a < b; });
+        }
+
+        template <size_t... I, typename C>
+        void sort_by_view(C&& comparator) {
+            reset_sort_reference();
+
+            auto comparator_wrapper = [&](size_t a, size_t b) {
+                return comparator(this->view<I...>(a),
+                                  this->view<I...>(b));
+            };
+
+            std::stable_sort(sort_order_reference_.begin(),
+                sort_order_reference_.end(),
+                comparator_wrapper);
+
+            relocate(capacity(), [&](size_t row) { return sort_order_reference_[row]; });
+        }
+
+        template <size_t... I>
+        void sort_by_view() {
+            sort_by_view<I...>([](auto&& a, auto&& b) { return a < b; });
+        }
+
+        void dump(std::basic_ostream<char>& ss) const {
+            dump_rows(ss, "ring_soa", *this);
+        }
+
+        void set_growable(bool growable = true) {
+            growable_ = growable;
+        }
+
+    private:
+        size_t wrap(size_t physical) const {
+            return physical >= capacity() ? physical - capacity() : physical;
+        }
+
+        size_t physical_row(size_t row) const {
+            return wrap(head_ + row);
+        }
+
+        template <typename T, size_t... I>
+        void insert_impl(std::integer_sequence<size_t, I...>, T t, size_t physical) {
+            ((std::get<I>(data_)[physical] = std::get<I>(t)), ...);
+        }
+
+        template <size_t... I>
+        auto get_row_impl(std::integer_sequence<size_t, I...>, size_t physical) const {
+            return std::tie(std::get<I>(data_)[physical]...);
+        }
+
+        template <size_t... I>
+        auto get_row_impl(std::integer_sequence<size_t, I...>, size_t physical) {
+            return std::tie(std::get<I>(data_)[physical]...);
+        }
+
+        template <size_t... I, typename T>
+        void resize_impl(std::integer_sequence<size_t, I...>, T&& data, size_t new_size) {
+            ((std::get<I>(data).resize(new_size)), ...);
+        }
+
+        template <typename T>
+        std::pair<column_span<T>, column_span<T>> get_column_spans_impl(T* col) const {
+            const size_t first_size = std::min(size_, capacity() - head_);
+            return { column_span<T>(col + head_, first_size),
+                     column_span<T>(col, size_ - first_size) };
+        }
+
+        void reset_sort_reference() {
+            sort_order_reference_.resize(size_);
+            for (size_t i = 0; i < size_; ++i) {
+                sort_order_reference_[i] = i;
+            }
+        }
+
+        // Moves logical row source_row(i) of every column to physical row i
+        // of new buffers with new_capacity rows, which then replace the old ones.
+        template <typename F>
+        void relocate(size_t new_capacity, F&& source_row) {
+            // capacity() changes as soon as the first column is swapped,
+            // so physical rows are computed from the old capacity
+            const size_t old_capacity = capacity();
+            auto source_physical_row = [&](size_t row) {
+                size_t physical = head_ + source_row(row);
+                return physical >= old_capacity ? physical - old_capacity : physical;
+            };
+            relocate_impl(std::index_sequence_for<Ts...>{}, new_capacity, source_physical_row);
+            head_ = 0;
+        }
+
+        template <size_t... I, typename F>
+        void relocate_impl(std::integer_sequence<size_t, I...>, size_t new_capacity, F& source_physical_row) {
+            ((relocate_col(std::integral_constant<size_t, I>{}, new_capacity, source_physical_row)), ...);
+        }
+
+        template <size_t col_idx, typename F>
+        void relocate_col(std::integral_constant<size_t, col_idx>, size_t new_capacity, F& source_physical_row) {
+            auto& src = std::get<col_idx>(data_);
+            auto& dst = std::get<col_idx>(data_tmp_);
+
+            dst.resize(new_capacity);
+            for (size_t idx = 0; idx < size_; ++idx) {
+                dst[idx] = std::move(src[source_physical_row(idx)]);
+            }
+            std::swap(src, dst);
+        }
+
+        bool growable_ = true;
+
+        // index of the oldest row in the buffers
+        size_t head_ = 0;
+        size_t size_ = 0;
+
+        // every column is a buffer of capacity() rows
+        std::tuple<std::vector<Ts>...> data_;
+
+        // tmp buffers for reordering when sorting or growing
+        std::tuple<std::vector<Ts>...> data_tmp_;
+
+        // the reference permutation describing sorted order
+        std::vector<size_t> sort_order_reference_;
+    };
+
+    template <typename... Ts>
+    std::ostream& operator<<(std::ostream& cout, const vapid::ring_soa<Ts...>& soa) {
+        soa.dump(cout);
+        return cout;
+    }
+}
+
+#endif /* VAPID_RING_SOA_H */
@@ -2,10 +2,17 @@
 #define VAPID_SOA_H
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <thread>
 #include <vector>
 #include <tuple>
 #include <iostream>
 #include <ostream>
+#include <type_traits>
 
 namespace vapid {
 
@@ -32,6 +39,26 @@ namespace vapid {
         TupleDumper<std::integral_constant<uint16_t, 0>, T>::dump(ss, t);
     }
 
+    template <typename Table>
+    void dump_rows(std::basic_ostream<char>& ss, const char* name, const Table& table) {
+        constexpr size_t MAX_NUM_ELEMENTS_TO_PRINT = 25;
+        size_t num_elements_to_print = table.size();
+        if (num_elements_to_print > MAX_NUM_ELEMENTS_TO_PRINT) {
+            num_elements_to_print = MAX_NUM_ELEMENTS_TO_PRINT;
+        }
+        ss << name << " {\n";
+        for (size_t i = 0; i < num_elements_to_print; ++i) {
+            const auto t = table[i];
+            ss << "\t";
+            dump_tuple(ss, t);
+            ss << std::endl;
+        }
+        if (table.size() > MAX_NUM_ELEMENTS_TO_PRINT) {
+            ss << "\t..." << std::endl;
+        }
+        ss << "}" << std::endl;
+    }
+
     struct PermutationAnalysis {
         PermutationAnalysis() {}
         PermutationAnalysis(const std::vector<size_t>& permutation) {
@@ -109,6 +136,143 @@ namespace vapid {
         std::vector<size_t> cycle_mins;
     };
 
+    // true if no index appears twice in I...
+    template <size_t... I>
+    constexpr bool distinct_indices() {
+        constexpr size_t indices[] = { I..., 0 };
+        for (size_t i = 0; i < sizeof...(I); ++i) {
+            for (size_t j = 0; j < i; ++j) {
+                if (indices[i] == indices[j]) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // iterates the rows of a table as tuples of references
+    template <typename Table>
+    class row_iterator {
+    public:
+        row_iterator(Table* table, size_t row) : table_(table), row_(row) {}
+
+        auto operator*() const {
+            return (*table_)[row_];
+        }
+
+        row_iterator& operator++() {
+            ++row_;
+            return *this;
+        }
+
+        bool operator==(const row_iterator& other) const {
+            return row_ == other.row_;
+        }
+
+        bool operator!=(const row_iterator& other) const {
+            return row_ != other.row_;
+        }
+
+    private:
+        Table* table_;
+        size_t row_;
+    };
+
+    template <typename... Ts>
+    class soa_view {
+        /* A non-owning view over some columns of a soa, see soa::project.
+         * Ts are the column types, const qualified if the view is read only.
+         * The view points at the soa's std::vector columns themselves, so it
+         * follows along through insert, resize and sort. It is invalidated
+         * when the soa is moved from or destroyed.
+         */
+    public:
+        template <typename T>
+        using column_of = typename std::conditional<std::is_const<T>::value,
+                                                    const std::vector<typename std::remove_const<T>::type>,
+                                                    std::vector<T>>::type;
+
+        using backing_type = std::tuple<column_of<Ts>*...>;
+
+        template <size_t col_idx>
+        using nth_col_type = column_of<typename std::tuple_element<col_idx, std::tuple<Ts...>>::type>;
+
+        template <size_t col_idx>
+        using col_type = typename nth_col_type<col_idx>::value_type;
+
+        soa_view(column_of<Ts>&... columns) : data_(&columns...) {}
+
+        template<size_t col_idx>
+        nth_col_type<col_idx>& get_column() const {
+            return *std::get<col_idx>(data_);
+        }
+
+        size_t size() const {
+            return get_column<0>().size();
+        }
+
+        bool empty() const {
+            return get_column<0>().empty();
+        }
+
+        auto operator[](size_t idx) const {
+            return get_row_impl(std::index_sequence_for<Ts...>{}, idx);
+        }
+
+        template <size_t... I>
+        auto view(size_t row) const {
+            return get_row_impl(std::integer_sequence<size_t, I...>{}, row);
+        }
+
+        template <size_t... I>
+        auto project() const {
+            return soa_view<typename std::tuple_element<I, std::tuple<Ts...>>::type...>(get_column<I>()...);
+        }
+
+        row_iterator<const soa_view> begin() const {
+            return row_iterator<const soa_view>(this, 0);
+        }
+
+        row_iterator<const soa_view> end() const {
+            return row_iterator<const soa_view>(this, size());
+        }
+
+        void dump(std::basic_ostream<char>& ss) const {
+            dump_rows(ss, "soa_view", *this);
+        }
+
+    private:
+        template <size_t... I>
+        auto get_row_impl(std::integer_sequence<size_t, I...>, size_t row) const {
+            return std::tie(get_column<I>()[row]...);
+        }
+
+        backing_type data_;
+    };
+
+    // runs each task on its own detached thread
+    // the default executor of sort_by_field_async and sort_by_view_async
+    struct detached_thread_executor {
+        void operator()(std::function<void()> task) const {
+            std::thread(std::move(task)).detach();
+        }
+    };
+
+    // shared between a soa and the task running its background sort
+    // the promise is owned by the task alone, so that a task which is
+    // dropped without running breaks it instead of leaving waiters hanging
+    struct AsyncSortState {
+        // a queued task only runs if it can move queued to running, and
+        // cancelling only waits for the task if it could not move queued to
+        // abandoned, so an abandoned task never touches its soa
+        enum Stage { queued, running, abandoned };
+        std::atomic<Stage> stage{queued};
+        std::atomic<bool> cancelled{false};
+    };
+
+    // thrown from inside the background sort to abandon it once cancelled
+    struct AsyncSortCancelled {};
+
     template <typename... Ts>
     class soa {
     public:
@@ -134,6 +298,38 @@ namespace vapid {
              */
         }
 
+        // a background sort reads data_ and writes data_tmp_, so it is
+        // cancelled before the soa is destroyed, overwritten or moved from
+        ~soa() {
+            cancel_sort();
+        }
+
+        soa(const soa& other) {
+            copy_from(other);
+        }
+
+        soa(soa&& other) noexcept {
+            other.cancel_sort();
+            move_from(std::move(other));
+        }
+
+        soa& operator=(const soa& other) {
+            if (this != &other) {
+                cancel_sort();
+                copy_from(other);
+            }
+            return *this;
+        }
+
+        soa& operator=(soa&& other) noexcept {
+            if (this != &other) {
+                cancel_sort();
+                other.cancel_sort();
+                move_from(std::move(other));
+            }
+            return *this;
+        }
+
         template<size_t col_idx>
         const nth_col_type<col_idx>& get_column() const {
             return std::get<col_idx>(data_);
@@ -155,6 +351,7 @@ namespace vapid {
 
         template <typename... Xs>
         void insert(Xs... xs) {
+            cancel_sort();
             insert_impl(std::index_sequence_for<Ts...>{}, std::forward_as_tuple(xs...));
         }
 
@@ -176,20 +373,54 @@ namespace vapid {
             return get_row_impl(std::integer_sequence<size_t, I...>{}, row);
         }
 
+        template <size_t... I>
+        soa_view<col_type<I>...> project() & {
+            // non-owning view of columns I..., without copying them
+            return soa_view<col_type<I>...>(get_column<I>()...);
+        }
+
+        template <size_t... I>
+        soa_view<const col_type<I>...> project() const & {
+            return soa_view<const col_type<I>...>(get_column<I>()...);
+        }
+
+        // a view of a temporary soa would dangle
+        template <size_t... I>
+        void project() && = delete;
+
+        template <size_t... I>
+        void project() const && = delete;
+
+        template <size_t... I>
+        soa<col_type<I>...> extract() && {
+            // moves columns I... into a new soa
+            // the remaining columns are left behind in the moved-from soa
+            // usage: auto xy = std::move(table).extract<X, Y>();
+            static_assert(distinct_indices<I...>(), "extract: each column can only be moved out once");
+            cancel_sort();
+            soa<col_type<I>...> result;
+            extract_impl<I...>(std::index_sequence_for<col_type<I>...>{}, result);
+            return result;
+        }
+
         void clear() {
+            cancel_sort();
             return clear_impl(std::index_sequence_for<Ts...>{});
         }
 
         void resize(size_t size) {
+            cancel_sort();
             return resize_impl(std::index_sequence_for<Ts...>{}, data_, size);
         }
 
         void reserve(size_t size) {
+            cancel_sort();
             return reserve_impl(std::index_sequence_for<Ts...>{}, size);
         }
 
         template <size_t col_idx, typename C>
         void sort_by_field(C&& comparator) {
+            cancel_sort();
             reset_sort_reference();
 
             auto& col = get_column<col_idx>();
@@ -216,6 +447,7 @@ namespace vapid {
 
         template <size_t... I, typename C>
         void sort_by_view(C&& comparator) {
+            cancel_sort();
             reset_sort_reference();
 
             auto comparator_wrapper = [=](size_t a, size_t b) {
@@ -239,29 +471,136 @@ namespace vapid {
             sort_by_view<I...>([](auto&& a, auto&& b) { return a < b; });
         }
 
-        void dump(std::basic_ostream<char>& ss) const {
-            constexpr size_t MAX_NUM_ELEMENTS_TO_PRINT = 25;
-            size_t num_elements_to_print = size();
-            if (num_elements_to_print > MAX_NUM_ELEMENTS_TO_PRINT) {
-                num_elements_to_print = MAX_NUM_ELEMENTS_TO_PRINT;
+        /* Asynchronous sorting
+         *
+         * sort_by_field_async and sort_by_view_async compute the sort order
+         * and gather the sorted rows into the back buffers (data_tmp_) on
+         * executor, which is called with a std::function<void()> to run.
+         * Meanwhile the front buffers are left untouched and can be read
+         * through the const accessors. Writing through the non-const
+         * accessors while a sort is pending is a data race.
+         *
+         * The rows are copied rather than moved into the back buffers,
+         * since the front buffers must stay readable. Both buffers are
+         * always used, regardless of no_double_buffering.
+         *
+         * The returned future becomes true once the sorted rows are ready,
+         * or false if the sort was cancelled. The sorted rows replace the
+         * front buffers with commit_sort, or try_commit_sort which does not
+         * block and can be polled eg. once per frame.
+         *
+         * Anything that modifies the soa (insert, clear, resize, reserve,
+         * another sort, assignment, destruction) first cancels the pending
+         * sort and waits for its task to stop, since its result would be
+         * stale. The task checks for cancellation on every comparison, so
+         * this wait is short. A task that the executor has not started yet
+         * is not waited for; when it does run, it only sets its future to false.
+         */
+        template <size_t col_idx, typename C, typename E>
+        std::shared_future<bool> sort_by_field_async(C comparator, E&& executor) {
+            return start_async_sort([comparator](const soa& self, size_t a, size_t b) {
+                const auto& col = std::get<col_idx>(self.data_);
+                return comparator(col[a], col[b]);
+            }, executor);
+        }
+
+        template <size_t col_idx, typename C>
+        std::shared_future<bool> sort_by_field_async(C comparator) {
+            return sort_by_field_async<col_idx>(comparator, detached_thread_executor{});
+        }
+
+        template <size_t col_idx>
+        std::shared_future<bool> sort_by_field_async() {
+            return sort_by_field_async<col_idx>([](auto&& a, auto&& b) { return a < b; });
+        }
+
+        template <size_t... I, typename C, typename E>
+        std::shared_future<bool> sort_by_view_async(C comparator, E&& executor) {
+            return start_async_sort([comparator](const soa& self, size_t a, size_t b) {
+                return comparator(self.view<I...>(a),
+                                  self.view<I...>(b));
+            }, executor);
+        }
+
+        template <size_t... I, typename C>
+        std::shared_future<bool> sort_by_view_async(C comparator) {
+            return sort_by_view_async<I...>(comparator, detached_thread_executor{});
+        }
+
+        template <size_t... I>
+        std::shared_future<bool> sort_by_view_async() {
+            return sort_by_view_async<I...>([](auto&& a, auto&& b) { return a < b; });
+        }
+
+        bool sort_pending() const {
+            return pending_sort_ != nullptr;
+        }
+
+        // Waits for the pending sort, then swaps the sorted back buffers to the front.
+        // Returns false if there was no pending sort or it was cancelled.
+        // Rethrows any exception thrown by the comparator.
+        bool commit_sort() {
+            if (!pending_sort_) {
+                return false;
+            }
+            if (pending_sort_->stage == AsyncSortState::abandoned) {
+                cancel_sort();
+                return false;
             }
-            ss << "soa {\n";
-            for (size_t i = 0; i < num_elements_to_print; ++i) {
-                const auto t = operator[](i);
-                ss << "\t";
-                dump_tuple(ss, t);
-                ss << std::endl;
+            std::shared_future<bool> result = std::move(pending_sort_result_);
+            pending_sort_.reset();
+            if (!result.get()) {
+                return false;
             }
-            if (size() > MAX_NUM_ELEMENTS_TO_PRINT) {
-                ss << "\t..." << std::endl;
+            swap_buffers_impl(std::index_sequence_for<Ts...>{});
+            return true;
+        }
+
+        // Like commit_sort, but returns false right away if the sort is still running.
+        bool try_commit_sort() {
+            if (!pending_sort_ ||
+                (pending_sort_->stage != AsyncSortState::abandoned &&
+                 pending_sort_result_.wait_for(std::chrono::seconds(0)) != std::future_status::ready)) {
+                return false;
             }
-            ss << "}" << std::endl;
+            return commit_sort();
+        }
+
+        // Asks the pending sort, if any, to stop without waiting for it.
+        // The sort stays pending until commit_sort or cancel_sort.
+        void request_cancel_sort() {
+            if (!pending_sort_) {
+                return;
+            }
+            auto expected = AsyncSortState::queued;
+            if (!pending_sort_->stage.compare_exchange_strong(expected, AsyncSortState::abandoned)) {
+                pending_sort_->cancelled = true;
+            }
+        }
+
+        // Stops the pending sort, if any, and waits for its task to finish
+        // if it had started. The front buffers are unchanged.
+        void cancel_sort() {
+            if (!pending_sort_) {
+                return;
+            }
+            request_cancel_sort();
+            if (pending_sort_->stage != AsyncSortState::abandoned) {
+                pending_sort_result_.wait();
+            }
+            pending_sort_.reset();
+            pending_sort_result_ = std::shared_future<bool>();
+        }
+
+        void dump(std::basic_ostream<char>& ss) const {
+            dump_rows(ss, "soa", *this);
         }
 
         void prepare_tmp() {
             // sorting requires the temporary buffers in data_tmp_
             // this function pre-allocates those temporary buffers
             // so that no allocation is done during the sort call
+            cancel_sort();
             return resize_impl(std::index_sequence_for<Ts...>{}, data_tmp_, size());
         }
 
@@ -270,6 +609,105 @@ namespace vapid {
         }
 
     private:
+        void copy_from(const soa& other) {
+            no_double_buffering_ = other.no_double_buffering_;
+            data_ = other.data_;
+            // the back buffers of other are being written by its pending sort
+            if (!other.sort_pending()) {
+                data_tmp_ = other.data_tmp_;
+            }
+        }
+
+        void move_from(soa&& other) {
+            no_double_buffering_ = other.no_double_buffering_;
+            data_ = std::move(other.data_);
+            data_tmp_ = std::move(other.data_tmp_);
+            sort_order_reference_ = std::move(other.sort_order_reference_);
+            sort_order_analysis_ = std::move(other.sort_order_analysis_);
+        }
+
+        template <typename C, typename E>
+        std::shared_future<bool> start_async_sort(C row_less, E& executor) {
+            cancel_sort();
+            reset_sort_reference();
+
+            auto state = std::make_shared<AsyncSortState>();
+            auto done = std::make_shared<std::promise<bool>>();
+            std::shared_future<bool> result = done->get_future().share();
+
+            executor(std::function<void()>([this, state, done, row_less]() {
+                auto expected = AsyncSortState::queued;
+                if (!state->stage.compare_exchange_strong(expected, AsyncSortState::running)) {
+                    // abandoned while queued, the soa may be gone
+                    done->set_value(false);
+                    return;
+                }
+                try {
+                    done->set_value(sort_into_back_buffers(state->cancelled, row_less));
+                } catch (const AsyncSortCancelled&) {
+                    done->set_value(false);
+                } catch (...) {
+                    done->set_exception(std::current_exception());
+                }
+            }));
+
+            // only published once the executor accepted the task
+            // if it threw, there is nothing to wait for
+            pending_sort_ = state;
+            pending_sort_result_ = result;
+            return result;
+        }
+
+        // runs on the executor
+        template <typename C>
+        bool sort_into_back_buffers(const std::atomic<bool>& cancelled, const C& row_less) {
+            if (cancelled) {
+                return false;
+            }
+
+            // the front buffers are only read
+            // cancellation is checked on every comparison, and unwinds out of
+            // the sort, so that cancel_sort only waits for a few comparisons
+            const soa& self = *this;
+            std::stable_sort(sort_order_reference_.begin(),
+                sort_order_reference_.end(),
+                [&](size_t a, size_t b) {
+                    if (cancelled.load(std::memory_order_relaxed)) {
+                        throw AsyncSortCancelled{};
+                    }
+                    return row_less(self, a, b);
+                });
+
+            return gather_into_back_impl(std::index_sequence_for<Ts...>{}, cancelled);
+        }
+
+        template <size_t... I>
+        bool gather_into_back_impl(std::integer_sequence<size_t, I...>, const std::atomic<bool>& cancelled) {
+            // stops at the first column that sees the cancellation
+            return ((gather_col_into_back(std::integral_constant<size_t, I>{}, cancelled)) && ...);
+        }
+
+        template <size_t col_idx>
+        bool gather_col_into_back(std::integral_constant<size_t, col_idx>, const std::atomic<bool>& cancelled) {
+            constexpr size_t ROWS_PER_CANCEL_CHECK = 1024;
+            const auto& src = std::get<col_idx>(data_);
+            auto& dst = std::get<col_idx>(data_tmp_);
+
+            dst.resize(src.size());
+            for (size_t idx = 0; idx < src.size(); ++idx) {
+                if (idx % ROWS_PER_CANCEL_CHECK == 0 && cancelled.load(std::memory_order_relaxed)) {
+                    return false;
+                }
+                dst[idx] = src[sort_order_reference_[idx]];
+            }
+            return true;
+        }
+
+        template <size_t... I>
+        void swap_buffers_impl(std::integer_sequence<size_t, I...>) {
+            ((std::swap(std::get<I>(data_), std::get<I>(data_tmp_))), ...);
+        }
+
         template <typename T, size_t... I>
         void insert_impl(std::integer_sequence<size_t, I...>, T t) {
             ((get_column<I>().push_back(std::get<I>(t))), ...);
@@ -285,6 +723,12 @@ namespace vapid {
             return std::tie(get_column<I>()[row]...);
         }
 
+        template <size_t... I, size_t... J, typename T>
+        void extract_impl(std::integer_sequence<size_t, J...>, T& result) {
+            constexpr size_t src_cols[] = { I... };
+            ((result.template get_column<J>() = std::move(get_column<src_cols[J]>())), ...);
+        }
+
         template <size_t... I>
         void clear_impl(std::integer_sequence<size_t, I...>) {
             ((get_column<I>().clear()), ...);
@@ -347,6 +791,7 @@ namespace vapid {
 
         // tmp buffers for reordering when sorting
         // disable this by setting no_double_buffering=true
+        // written by the background task while an async sort is pending
         std::tuple<std::vector<Ts>...> data_tmp_;
 
         // the reference permutation describing sorted order
@@ -355,6 +800,10 @@ namespace vapid {
         // permutation analysis used in single buffering mode
         PermutationAnalysis sort_order_analysis_;
 
+        // state of the pending async sort, null if there is none
+        std::shared_ptr<AsyncSortState> pending_sort_;
+        std::shared_future<bool> pending_sort_result_;
+
     };
 
     template <typename... Ts>
@@ -362,6 +811,12 @@ namespace vapid {
         soa.dump(cout);
         return cout;
     }
+
+    template <typename... Ts>
+    std::ostream& operator<<(std::ostream& cout, const vapid::soa_view<Ts...>& view) {
+        view.dump(cout);
+        return cout;
+    }
 }
 
 
@@ -0,0 +1,48 @@
+#ifndef VAPID_SPAN_H
+#define VAPID_SPAN_H
+
+#include <cstddef>
+
+namespace vapid {
+
+    // Minimal non-owning view of a contiguous run of column elements
+    // (std::span is c++20). T is const qualified for read only access.
+    template <typename T>
+    class column_span {
+    public:
+        using value_type = T;
+
+        constexpr column_span() {}
+        constexpr column_span(T* data, size_t size) : data_(data), size_(size) {}
+
+        constexpr T* data() const {
+            return data_;
+        }
+
+        constexpr size_t size() const {
+            return size_;
+        }
+
+        constexpr bool empty() const {
+            return size_ == 0;
+        }
+
+        constexpr T& operator[](size_t idx) const {
+            return data_[idx];
+        }
+
+        constexpr T* begin() const {
+            return data_;
+        }
+
+        constexpr T* end() const {
+            return data_ + size_;
+        }
+
+    private:
+        T* data_ = nullptr;
+        size_t size_ = 0;
+    };
+}
+
+#endif /* VAPID_SPAN_H */
@@ -0,0 +1,281 @@
+#ifndef VAPID_STATIC_SOA_H
+#define VAPID_STATIC_SOA_H
+
+#include <algorithm>
+#include <array>
+#include <ostream>
+#include <tuple>
+#include <utility>
+#include "vapid/soa.h"
+#include "vapid/span.h"
+
+namespace vapid {
+
+    template <size_t col_idx, size_t N, typename T>
+    struct static_column {
+        std::array<T, N> values;
+    };
+
+    // Inline storage for the columns of a static_soa.
+    // std::tuple is not used because its default constructor
+    // value initializes, which would zero every row of every
+    // column whenever a table is created.
+    template <size_t N, typename Seq, typename... Ts>
+    struct static_columns;
+
+    template <size_t N, size_t... I, typename... Ts>
+    struct static_columns<N, std::integer_sequence<size_t, I...>, Ts...> : static_column<I, N, Ts>... {};
+
+    template <size_t N, typename... Ts>
+    class static_soa {
+        /* A structure of arrays with a fixed capacity of N rows.
+         * Columns are std::arrays stored inline, and sorting uses
+         * scratch space on the stack, so a static_soa never touches
+         * the heap. Meant for small tables that are created and
+         * sorted often, eg. once per frame.
+         *
+         * The api mirrors soa, except get_column returns a
+         * column_span over the rows in use instead of a std::vector.
+         * insert and resize never grow past N: on a full table they
+         * return false and leave the table unchanged.
+         *
+         * Member functions are constexpr, but since rows are left
+         * uninitialized until inserted, a static_soa can only be used
+         * in constant expressions from c++20 onward.
+         */
+    public:
+        using backing_type = static_columns<N, std::index_sequence_for<Ts...>, Ts...>;
+
+        template <size_t col_idx>
+        using col_type = typename std::tuple_element<col_idx, std::tuple<Ts...>>::type;
+
+        constexpr static_soa() {}
+
+        template<size_t col_idx>
+        constexpr column_span<const col_type<col_idx>> get_column() const {
+            return column_span<const col_type<col_idx>>(array<col_idx>().data(), size_);
+        }
+
+        template<size_t col_idx>
+        constexpr column_span<col_type<col_idx>> get_column() {
+            return column_span<col_type<col_idx>>(array<col_idx>().data(), size_);
+        }
+
+        static constexpr size_t capacity() {
+            return N;
+        }
+
+        constexpr size_t size() const {
+            return size_;
+        }
+
+        constexpr bool empty() const {
+            return size_ == 0;
+        }
+
+        constexpr bool full() const {
+            return size_ == N;
+        }
+
+        // Returns false, without inserting, if the table is full.
+        template <typename... Xs>
+        constexpr bool insert(Xs... xs) {
+            if (size_ == N) {
+                return false;
+            }
+            insert_impl(std::index_sequence_for<Ts...>{}, std::forward_as_tuple(xs...));
+            ++size_;
+            return true;
+        }
+
+        constexpr auto operator[](size_t idx) const {
+            return get_row_impl(std::index_sequence_for<Ts...>{}, idx);
+        }
+
+        constexpr auto operator[](size_t idx) {
+            return get_row_impl(std::index_sequence_for<Ts...>{}, idx);
+        }
+
+        template <size_t... I>
+        constexpr auto view(size_t row) const {
+            return get_row_impl(std::integer_sequence<size_t, I...>{}, row);
+        }
+
+        template <size_t... I>
+        constexpr auto view(size_t row) {
+            return get_row_impl(std::integer_sequence<size_t, I...>{}, row);
+        }
+
+        constexpr void clear() {
+            // elements beyond size() keep their old values
+            // they are overwritten by later inserts
+            size_ = 0;
+        }
+
+        // Returns false, without resizing, if size is over capacity.
+        constexpr bool resize(size_t size) {
+            // like soa::resize, new rows are value initialized
+            if (size > N) {
+                return false;
+            }
+            for (size_t row = size_; row < size; ++row) {
+                value_init_row_impl(std::index_sequence_for<Ts...>{}, row);
+            }
+            size_ = size;
+            return true;
+        }
+
+        template <size_t col_idx, typename C>
+        constexpr void sort_by_field(C&& comparator) {
+            sort_by_rows([&](size_t a, size_t b) {
+                return comparator(array<col_idx>()[a], array<col_idx>()[b]);
+            });
+        }
+
+        template <size_t col_idx>
+        constexpr void sort_by_field() {
+            sort_by_field<col_idx>([](auto&& a, auto&& b) { return a < b; });
+        }
+
+        template <size_t... I, typename C>
+        constexpr void sort_by_view(C&& comparator) {
+            sort_by_rows([&](size_t a, size_t b) {
+                return comparator(this->view<I...>(a),
+                                  this->view<I...>(b));
+            });
+        }
+
+        template <size_t... I>
+        constexpr void sort_by_view() {
+            sort_by_view<I...>([](auto&& a, auto&& b) { return a < b; });
+        }
+
+        void dump(std::basic_ostream<char>& ss) const {
+            dump_rows(ss, "static_soa", *this);
+        }
+
+    private:
+        template <size_t col_idx>
+        constexpr const std::array<col_type<col_idx>, N>& array() const {
+            return static_cast<const static_column<col_idx, N, col_type<col_idx>>&>(data_).values;
+        }
+
+        template <size_t col_idx>
+        constexpr std::array<col_type<col_idx>, N>& array() {
+            return static_cast<static_column<col_idx, N, col_type<col_idx>>&>(data_).values;
+        }
+
+        template <typename T, size_t... I>
+        constexpr void insert_impl(std::integer_sequence<size_t, I...>, T t) {
+            ((array<I>()[size_] = std::get<I>(t)), ...);
+        }
+
+        template <size_t... I>
+        constexpr void value_init_row_impl(std::integer_sequence<size_t, I...>, size_t row) {
+            ((array<I>()[row] = col_type<I>{}), ...);
+        }
+
+        template <size_t... I>
+        constexpr auto get_row_impl(std::integer_sequence<size_t, I...>, size_t row) const {
+            return std::tie(array<I>()[row]...);
+        }
+
+        template <size_t... I>
+        constexpr auto get_row_impl(std::integer_sequence<size_t, I...>, size_t row) {
+            return std::tie(array<I>()[row]...);
+        }
+
+        template <typename C>
+        constexpr void sort_by_rows(C&& row_less) {
+            // stable bottom up merge sort of the row order
+            // std::stable_sort may allocate a heap buffer
+            std::array<size_t, N> order;
+            std::array<size_t, N> scratch;
+            for (size_t i = 0; i < size_; ++i) {
+                order[i] = i;
+            }
+
+            // insertion sort short runs first, merging is not worth it below this
+            constexpr size_t RUN_LENGTH = 8;
+            for (size_t lo = 0; lo < size_; lo += RUN_LENGTH) {
+                const size_t hi = std::min(lo + RUN_LENGTH, size_);
+                for (size_t i = lo + 1; i < hi; ++i) {
+                    const size_t row = order[i];
+                    size_t j = i;
+                    while (j > lo && row_less(row, order[j-1])) {
+                        order[j] = order[j-1];
+                        --j;
+                    }
+                    order[j] = row;
+                }
+            }
+
+            size_t* src = order.data();
+            size_t* dst = scratch.data();
+            for (size_t width = RUN_LENGTH; width < size_; width *= 2) {
+                for (size_t lo = 0; lo < size_; lo += 2 * width) {
+                    const size_t mid = std::min(lo + width, size_);
+                    const size_t hi = std::min(lo + 2 * width, size_);
+                    size_t a = lo;
+                    size_t b = mid;
+                    size_t out = lo;
+                    while (a < mid && b < hi) {
+                        dst[out++] = row_less(src[b], src[a]) ? src[b++] : src[a++];
+                    }
+                    while (a < mid) {
+                        dst[out++] = src[a++];
+                    }
+                    while (b < hi) {
+                        dst[out++] = src[b++];
+                    }
+                }
+                size_t* tmp = src;
+                src = dst;
+                dst = tmp;
+            }
+
+            permute_impl(std::index_sequence_for<Ts...>{}, src);
+        }
+
+        template <size_t... I>
+        constexpr void permute_impl(std::integer_sequence<size_t, I...>, const size_t* order) {
+            ((permute_col(array<I>(), order)), ...);
+        }
+
+        template <typename T>
+        constexpr void permute_col(std::array<T, N>& col, const size_t* order) {
+            // in place, following each cycle of the permutation so that
+            // only a single element of temporary storage is needed
+            std::array<bool, N> visited{};
+            for (size_t i = 0; i < size_; ++i) {
+                if (visited[i]) {
+                    continue;
+                }
+                T tmp = std::move(col[i]);
+                size_t j = i;
+                while (true) {
+                    visited[j] = true;
+                    const size_t k = order[j];
+                    if (k == i) {
+                        break;
+                    }
+                    col[j] = std::move(col[k]);
+                    j = k;
+                }
+                col[j] = std::move(tmp);
+            }
+        }
+
+        size_t size_ = 0;
+
+        backing_type data_;
+    };
+
+    template <size_t N, typename... Ts>
+    std::ostream& operator<<(std::ostream& cout, const vapid::static_soa<N, Ts...>& soa) {
+        soa.dump(cout);
+        return cout;
+    }
+}
+
+#endif /* VAPID_STATIC_SOA_H */